@@ -0,0 +1,114 @@
+#include "gzip_writer.h"
+
+#include <cstdio>
+#include <stdexcept>
+#include <zlib.h>
+
+namespace {
+
+constexpr size_t kOutChunk = 64 * 1024;
+constexpr int kGzipWindowBits = 15 + 16; // +16 — gzip-заголовок вместо zlib
+
+}
+
+GzipWriter::GzipWriter(const std::string& path) : path(path) {
+    file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        throw std::runtime_error("Cannot write to file: " + path);
+    }
+    worker = std::thread(&GzipWriter::run, this);
+}
+
+GzipWriter::~GzipWriter() {
+    try {
+        finish();
+    } catch (...) {
+    }
+}
+
+void GzipWriter::write(std::string chunk) {
+    if (chunk.empty()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back(std::move(chunk));
+    }
+    ready.notify_one();
+}
+
+void GzipWriter::finish() {
+    if (!worker.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+    }
+    ready.notify_one();
+    worker.join();
+
+    if (std::fclose(file) != 0 && error.empty()) {
+        error = "Cannot write to file: " + path;
+    }
+    file = nullptr;
+    if (!error.empty()) {
+        throw std::runtime_error(error);
+    }
+}
+
+void GzipWriter::run() {
+    z_stream stream{};
+    if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, kGzipWindowBits, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        std::lock_guard<std::mutex> lock(mutex);
+        error = "Cannot initialize gzip stream";
+        return;
+    }
+
+    unsigned char out[kOutChunk];
+    std::string failure;
+    // Возвращает false при ошибке zlib или записи; с Z_FINISH поток должен завершиться Z_STREAM_END
+    auto deflateAll = [&](int flush) {
+        int ret = Z_OK;
+        do {
+            stream.next_out = out;
+            stream.avail_out = kOutChunk;
+            ret = deflate(&stream, flush);
+            if (ret != Z_OK && ret != Z_BUF_ERROR && ret != Z_STREAM_END) {
+                failure = "gzip stream error (" + std::to_string(ret) + "): " + path;
+                return false;
+            }
+            size_t produced = kOutChunk - stream.avail_out;
+            if (std::fwrite(out, 1, produced, file) != produced) {
+                failure = "Cannot write to file: " + path;
+                return false;
+            }
+        } while (stream.avail_out == 0);
+        if (flush == Z_FINISH && ret != Z_STREAM_END) {
+            failure = "gzip stream was not finished: " + path;
+            return false;
+        }
+        return true;
+    };
+
+    for (;;) {
+        std::string chunk;
+        bool last = false;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            ready.wait(lock, [&] { return !queue.empty() || closed; });
+            if (!queue.empty()) {
+                chunk = std::move(queue.front());
+                queue.pop_front();
+            }
+            last = closed && queue.empty();
+        }
+
+        stream.next_in = reinterpret_cast<Bytef*>(chunk.data());
+        stream.avail_in = static_cast<uInt>(chunk.size());
+        // После ошибки оставшиеся куски не сжимаем, finish() бросит исключение
+        if (!deflateAll(last ? Z_FINISH : Z_NO_FLUSH) || last) break;
+    }
+
+    deflateEnd(&stream);
+    if (!failure.empty()) {
+        std::lock_guard<std::mutex> lock(mutex);
+        error = failure;
+    }
+}
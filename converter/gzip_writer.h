@@ -0,0 +1,35 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Пишет gzip-файл в отдельном потоке: write() только кладёт кусок в очередь,
+// сжатие идёт параллельно с рендерингом
+class GzipWriter {
+public:
+    explicit GzipWriter(const std::string& path);
+    ~GzipWriter();
+
+    GzipWriter(const GzipWriter&) = delete;
+    GzipWriter& operator=(const GzipWriter&) = delete;
+
+    void write(std::string chunk);
+    // Дожимает очередь и закрывает файл; бросает std::runtime_error при ошибке
+    void finish();
+
+private:
+    void run();
+
+    std::string path;
+    std::FILE* file = nullptr;
+    std::deque<std::string> queue;
+    std::mutex mutex;
+    std::condition_variable ready;
+    bool closed = false;
+    std::string error;
+    std::thread worker;
+};
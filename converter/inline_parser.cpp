@@ -136,3 +136,11 @@ std::vector<InlineElement> parseInline(const std::string& s) {
 
     return output;
 }
+
+std::string inlinePlainText(const std::vector<InlineElement>& elements) {
+    std::string text;
+    for (const auto& el : elements) {
+        text += el.content;
+    }
+    return text;
+}
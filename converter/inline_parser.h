@@ -18,3 +18,5 @@ struct InlineElement {
 };
 
 std::vector<InlineElement> parseInline(const std::string& input);
+// Текст элементов без разметки (для заголовков и якорей)
+std::string inlinePlainText(const std::vector<InlineElement>& elements);
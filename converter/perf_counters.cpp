@@ -0,0 +1,173 @@
+#include "perf_counters.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+static int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+#ifdef __linux__
+
+static int openCounter(uint32_t type, uint64_t config, int groupFd) {
+    perf_event_attr attr{};
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    // Управляем всей группой через лидера; читаем её одним read()
+    attr.disabled = groupFd < 0 ? 1 : 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, groupFd, 0));
+}
+
+static constexpr uint64_t cacheMiss(uint64_t cache) {
+    return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+}
+
+// Все счётчики — одна группа с лидером cycles: ядро включает их на PMU только вместе,
+// поэтому cycles и instructions считаются на одном и том же интервале
+PerfCounters::PerfCounters() {
+    const struct {
+        PerfEvent event;
+        uint32_t type;
+        uint64_t config;
+    } events[] = {
+        {PerfEvent::Cycles, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+        {PerfEvent::Instructions, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+        {PerfEvent::BranchMisses, PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+        {PerfEvent::L1dMisses, PERF_TYPE_HW_CACHE, cacheMiss(PERF_COUNT_HW_CACHE_L1D)},
+        {PerfEvent::LlcMisses, PERF_TYPE_HW_CACHE, cacheMiss(PERF_COUNT_HW_CACHE_LL)},
+    };
+    for (int& fd : fds) fd = -1;
+    for (const auto& e : events) {
+        // Если cycles недоступен, лидером становится первый открывшийся счётчик
+        int fd = openCounter(e.type, e.config, leader);
+        if (fd < 0) continue;
+        if (leader < 0) leader = fd;
+        fds[static_cast<size_t>(e.event)] = fd;
+        order[groupSize++] = e.event;
+    }
+}
+
+PerfCounters::~PerfCounters() {
+    for (int fd : fds) {
+        if (fd >= 0) close(fd);
+    }
+}
+
+void PerfCounters::start() {
+    if (leader >= 0) {
+        ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+    startNs = nowNs();
+}
+
+PerfSample PerfCounters::stop() {
+    PerfSample sample;
+    sample.wallNs = static_cast<double>(nowNs() - startNs);
+    if (leader < 0) {
+        return sample;
+    }
+    ioctl(leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+    // Формат PERF_FORMAT_GROUP: nr, time_enabled, time_running, значения в порядке открытия
+    uint64_t buf[3 + kPerfEventCount] = {};
+    ssize_t got = read(leader, buf, sizeof(buf));
+    if (got < static_cast<ssize_t>(3 * sizeof(uint64_t)) || buf[0] != groupSize) {
+        return sample;
+    }
+    uint64_t enabled = buf[1];
+    uint64_t running = buf[2];
+    if (running == 0) {
+        return sample; // группа так и не попала на PMU
+    }
+    // При мультиплексировании PMU группа считала только часть времени — экстраполируем
+    double scale = static_cast<double>(enabled) / static_cast<double>(running);
+    sample.multiplexed = running < enabled;
+    for (size_t k = 0; k < groupSize; ++k) {
+        size_t index = static_cast<size_t>(order[k]);
+        sample.values[index] = static_cast<uint64_t>(static_cast<double>(buf[3 + k]) * scale);
+        sample.valid[index] = true;
+    }
+    return sample;
+}
+
+#else
+
+PerfCounters::PerfCounters() {
+    for (int& fd : fds) fd = -1;
+}
+
+PerfCounters::~PerfCounters() = default;
+
+void PerfCounters::start() {
+    startNs = nowNs();
+}
+
+PerfSample PerfCounters::stop() {
+    PerfSample sample;
+    sample.wallNs = static_cast<double>(nowNs() - startNs);
+    return sample;
+}
+
+#endif
+
+bool PerfCounters::available() const {
+    for (int fd : fds) {
+        if (fd >= 0) return true;
+    }
+    return false;
+}
+
+void PerfSample::add(const PerfSample& other) {
+    wallNs += other.wallNs;
+    for (size_t k = 0; k < kPerfEventCount; ++k) {
+        if (!other.valid[k]) continue;
+        values[k] += other.values[k];
+        valid[k] = true;
+    }
+    multiplexed = multiplexed || other.multiplexed;
+}
+
+std::string formatPerfSample(const std::string& stage, const PerfSample& sample, size_t bytes) {
+    double perByte = bytes > 0 ? 1.0 / static_cast<double>(bytes) : 0.0;
+    double perKb = perByte * 1024.0;
+    char buf[128];
+    std::string line = stage;
+    line.resize(std::max<size_t>(line.size(), 12), ' ');
+
+    std::snprintf(buf, sizeof(buf), "%10.2f ns/B", sample.wallNs * perByte);
+    line += buf;
+    auto add = [&](PerfEvent e, const char* fmt, double scale) {
+        if (!sample.has(e)) return;
+        std::snprintf(buf, sizeof(buf), fmt, static_cast<double>(sample.get(e)) * scale);
+        line += buf;
+    };
+    add(PerfEvent::Cycles, "  %8.2f cyc/B", perByte);
+    add(PerfEvent::Instructions, "  %8.2f ins/B", perByte);
+    if (sample.has(PerfEvent::Cycles) && sample.has(PerfEvent::Instructions) && sample.get(PerfEvent::Cycles) > 0) {
+        std::snprintf(buf, sizeof(buf), "  IPC %5.2f",
+                      static_cast<double>(sample.get(PerfEvent::Instructions))
+                      / static_cast<double>(sample.get(PerfEvent::Cycles)));
+        line += buf;
+    }
+    add(PerfEvent::BranchMisses, "  %8.2f br-miss/KB", perKb);
+    add(PerfEvent::L1dMisses, "  %8.2f L1d-miss/KB", perKb);
+    add(PerfEvent::LlcMisses, "  %8.2f LLC-miss/KB", perKb);
+    if (sample.multiplexed) {
+        line += "  (scaled, PMU multiplexed)";
+    }
+    return line + "\n";
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Аппаратные счётчики через perf_event_open (Linux). Если счётчик недоступен
+// (контейнер, perf_event_paranoid, не Linux), он просто не попадает в отчёт
+enum class PerfEvent {
+    Cycles,
+    Instructions,
+    BranchMisses,
+    L1dMisses,
+    LlcMisses,
+    Count
+};
+
+constexpr size_t kPerfEventCount = static_cast<size_t>(PerfEvent::Count);
+
+struct PerfSample {
+    double wallNs = 0;
+    uint64_t values[kPerfEventCount] = {};
+    bool valid[kPerfEventCount] = {};
+    bool multiplexed = false; // значения экстраполированы по time_enabled / time_running
+
+    bool has(PerfEvent e) const { return valid[static_cast<size_t>(e)]; }
+    uint64_t get(PerfEvent e) const { return values[static_cast<size_t>(e)]; }
+    // Добавляет замер той же стадии, прерывавшейся другими (рендер идёт пачками)
+    void add(const PerfSample& other);
+};
+
+class PerfCounters {
+public:
+    PerfCounters();
+    ~PerfCounters();
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    bool available() const;
+
+    void start();
+    PerfSample stop();
+
+private:
+    int fds[kPerfEventCount];
+    int leader = -1;
+    PerfEvent order[kPerfEventCount] = {}; // порядок счётчиков в группе
+    size_t groupSize = 0;
+    int64_t startNs = 0;
+};
+
+// Одна строка отчёта: значения на байт входа, IPC и промахи на КБ
+std::string formatPerfSample(const std::string& stage, const PerfSample& sample, size_t bytes);
@@ -2,59 +2,250 @@
 #include "inline_parser.h"
 #include "utils.h"
 
-static std::string renderInline(const std::string& text) {
-    std::string result;
-    auto elements = parseInline(text);
+#include <algorithm>
+#include <cassert>
+#include <string_view>
+
+// Рендер в два шага: блок разбирается и считается точный размер его HTML
+// (с учётом экранирования), затем пишется на месте
+
+struct PreparedBlock {
+    const BlockToken* token = nullptr;
+    std::vector<std::vector<InlineElement>> lines;
+    size_t heading = 0; // номер в HeadingIndex, если заголовок с якорем
+    bool hasAnchor = false;
+    size_t size = 0;
+};
+
+static constexpr std::string_view kLiOpen = "  <li>";
+static constexpr std::string_view kLiClose = "</li>\n";
+
+static size_t inlineSize(const std::vector<InlineElement>& elements) {
+    size_t size = 0;
+    for (const auto& el : elements) {
+        size += escapedHtmlSize(el.content);
+        switch (el.type) {
+            case InlineType::Text:     break;
+            case InlineType::Emphasis: size += 9;  break; // <em></em>
+            case InlineType::Strong:   size += 17; break; // <strong></strong>
+            case InlineType::CodeSpan: size += 13; break; // <code></code>
+            case InlineType::Link:     size += 15 + escapedHtmlSize(el.url); break; // <a href=""></a>
+        }
+    }
+    return size;
+}
+
+static void appendInline(std::string& out, const std::vector<InlineElement>& elements) {
     for (const auto& el : elements) {
         switch (el.type) {
             case InlineType::Text:
-                result += escapeHtml(el.content);
+                appendEscapedHtml(out, el.content);
                 break;
             case InlineType::Emphasis:
-                result += "<em>" + escapeHtml(el.content) + "</em>";
+                out += "<em>";
+                appendEscapedHtml(out, el.content);
+                out += "</em>";
                 break;
             case InlineType::Strong:
-                result += "<strong>" + escapeHtml(el.content) + "</strong>";
+                out += "<strong>";
+                appendEscapedHtml(out, el.content);
+                out += "</strong>";
                 break;
             case InlineType::CodeSpan:
-                result += "<code>" + escapeHtml(el.content) + "</code>";
+                out += "<code>";
+                appendEscapedHtml(out, el.content);
+                out += "</code>";
                 break;
             case InlineType::Link:
-                result += "<a href=\"" + escapeHtml(el.url) + "\">"
-                        + escapeHtml(el.content) + "</a>";
+                out += "<a href=\"";
+                appendEscapedHtml(out, el.url);
+                out += "\">";
+                appendEscapedHtml(out, el.content);
+                out += "</a>";
                 break;
         }
     }
-    return result;
 }
 
-std::string renderHtml(const std::vector<BlockToken>& tokens) {
-    std::string html;
-    for (const auto& token : tokens) {
-        switch (token.type) {
-            case BlockType::Heading:
-                html += "<h" + std::to_string(token.level) + ">"
-                      + renderInline(token.lines[0])
-                      + "</h" + std::to_string(token.level) + ">\n";
-                break;
-            case BlockType::Paragraph:
-                html += "<p>" + renderInline(token.lines[0]) + "</p>\n";
-                break;
-            case BlockType::OrderedList:
-                html += "<ol>\n";
-                for (const auto& item : token.lines) {
-                    html += "  <li>" + renderInline(item) + "</li>\n";
-                }
-                html += "</ol>\n";
-                break;
-            case BlockType::UnorderedList:
-                html += "<ul>\n";
-                for (const auto& item : token.lines) {
-                    html += "  <li>" + renderInline(item) + "</li>\n";
+static void prepareBlock(PreparedBlock& block, const BlockToken& token, HeadingIndex* headings,
+                         SlugRegistry& usedSlugs) {
+    block.token = &token;
+    block.lines.clear();
+    block.hasAnchor = false;
+    for (const auto& line : token.lines) {
+        block.lines.push_back(parseInline(line));
+    }
+
+    size_t items = 0;
+    for (const auto& elements : block.lines) {
+        items += inlineSize(elements);
+    }
+
+    switch (token.type) {
+        case BlockType::Heading: {
+            size_t digits = std::to_string(token.level).size();
+            block.size = items + 2 * digits + 8; // <hN></hN>\n
+            if (headings) {
+                HeadingEntry entry;
+                entry.level = token.level;
+                entry.offset = token.offset;
+                entry.text = inlinePlainText(block.lines[0]);
+                if (token.slug.empty()) {
+                    entry.slug = uniqueSlug(entry.text, usedSlugs);
+                } else {
+                    // Якорь уже выдан индексом блоков для всего документа
+                    entry.slug = token.slug;
+                    usedSlugs.emplace(entry.slug, 0);
                 }
-                html += "</ul>\n";
-                break;
+                block.size += 6 + escapedHtmlSize(entry.slug); // ' id=""'
+                block.heading = headings->size();
+                block.hasAnchor = true;
+                headings->push_back(std::move(entry));
+            }
+            break;
         }
+        case BlockType::Paragraph:
+            block.size = items + 8; // <p></p>\n
+            break;
+        case BlockType::OrderedList:
+        case BlockType::UnorderedList:
+            block.size = items + 11 // <ol>\n</ol>\n
+                       + block.lines.size() * (kLiOpen.size() + kLiClose.size());
+            break;
     }
+}
+
+static void writeBlock(std::string& out, const PreparedBlock& block, const HeadingIndex* headings) {
+    const BlockToken& token = *block.token;
+    switch (token.type) {
+        case BlockType::Heading: {
+            std::string level = std::to_string(token.level);
+            out += "<h";
+            out += level;
+            if (block.hasAnchor) {
+                out += " id=\"";
+                appendEscapedHtml(out, (*headings)[block.heading].slug);
+                out += "\"";
+            }
+            out += ">";
+            appendInline(out, block.lines[0]);
+            out += "</h";
+            out += level;
+            out += ">\n";
+            break;
+        }
+        case BlockType::Paragraph:
+            out += "<p>";
+            appendInline(out, block.lines[0]);
+            out += "</p>\n";
+            break;
+        case BlockType::OrderedList:
+        case BlockType::UnorderedList:
+            out += token.type == BlockType::OrderedList ? "<ol>\n" : "<ul>\n";
+            for (const auto& elements : block.lines) {
+                out += kLiOpen;
+                appendInline(out, elements);
+                out += kLiClose;
+            }
+            out += token.type == BlockType::OrderedList ? "</ol>\n" : "</ul>\n";
+            break;
+    }
+}
+
+// Оценка размера HTML по длине строк, без разбора: на неё вывод резервируется
+// сразу, а точный размер блока лишь проверяется перед записью
+static size_t estimateHtmlSize(const std::vector<BlockToken>& tokens) {
+    size_t size = 0;
+    for (const auto& token : tokens) {
+        size += 16; // теги блока и перевод строки
+        for (const auto& line : token.lines) {
+            size += line.size() + line.size() / 8 + kLiOpen.size() + kLiClose.size();
+        }
+    }
+    return size;
+}
+
+// Блоки идут пачками: пачка разбирается и замеряется, затем пишется. Разобранной
+// держим только текущую пачку, а onStage зовём дважды на пачку, а не на каждый блок
+static constexpr size_t kRenderBatch = 64;
+
+template <typename WriteBatch>
+static void renderBatches(const std::vector<BlockToken>& tokens, HeadingIndex* headings,
+                          const RenderStageHook& onStage, WriteBatch writeBatch) {
+    std::vector<PreparedBlock> batch(std::min(tokens.size(), kRenderBatch));
+    SlugRegistry usedSlugs;
+    for (size_t first = 0; first < tokens.size(); first += kRenderBatch) {
+        size_t count = std::min(kRenderBatch, tokens.size() - first);
+        if (onStage) onStage(RenderStage::Inline);
+        size_t size = 0;
+        for (size_t k = 0; k < count; ++k) {
+            prepareBlock(batch[k], tokens[first + k], headings, usedSlugs);
+            size += batch[k].size;
+        }
+        if (onStage) onStage(RenderStage::Write);
+        writeBatch(batch.data(), count, size);
+    }
+}
+
+void streamHtml(const std::vector<BlockToken>& tokens, const HtmlSink& sink, HeadingIndex* headings,
+                const RenderStageHook& onStage) {
+    std::string html;
+    renderBatches(tokens, headings, onStage, [&](const PreparedBlock* blocks, size_t count, size_t) {
+        for (size_t k = 0; k < count; ++k) {
+            html.clear();
+            html.reserve(blocks[k].size);
+            writeBlock(html, blocks[k], headings);
+            assert(html.size() == blocks[k].size);
+            sink(html);
+        }
+    });
+}
+
+std::string renderHtml(const std::vector<BlockToken>& tokens, HeadingIndex* headings,
+                       const RenderStageHook& onStage) {
+    std::string html;
+    renderHtmlInto(html, tokens, headings, onStage);
     return html;
 }
+
+void renderHtmlInto(std::string& html, const std::vector<BlockToken>& tokens, HeadingIndex* headings,
+                    const RenderStageHook& onStage) {
+    html.clear();
+    html.reserve(estimateHtmlSize(tokens));
+    renderBatches(tokens, headings, onStage, [&](const PreparedBlock* blocks, size_t count, size_t size) {
+        size_t need = html.size() + size;
+        if (need > html.capacity()) {
+            // Оценка не сошлась — растём с запасом, чтобы не перевыделять на каждой пачке
+            html.reserve(std::max(need, html.capacity() * 2));
+        }
+        [[maybe_unused]] size_t before = html.size();
+        for (size_t k = 0; k < count; ++k) {
+            writeBlock(html, blocks[k], headings);
+        }
+        assert(html.size() - before == size); // замер и запись должны совпадать
+    });
+}
+
+std::string renderToc(const HeadingIndex& headings) {
+    std::string html = "<ul class=\"toc\">\n";
+    for (const auto& h : headings) {
+        html += "  <li class=\"toc-h" + std::to_string(h.level) + "\"><a href=\"#"
+              + escapeHtml(h.slug) + "\">" + escapeHtml(h.text) + "</a></li>\n";
+    }
+    html += "</ul>\n";
+    return html;
+}
+
+std::string renderTocJson(const HeadingIndex& headings) {
+    std::string json = "[";
+    for (size_t i = 0; i < headings.size(); ++i) {
+        const auto& h = headings[i];
+        if (i > 0) json += ",";
+        json += "\n  {\"level\": " + std::to_string(h.level)
+              + ", \"text\": \"" + escapeJson(h.text)
+              + "\", \"offset\": " + std::to_string(h.offset)
+              + ", \"slug\": \"" + escapeJson(h.slug) + "\"}";
+    }
+    json += headings.empty() ? "]\n" : "\n]\n";
+    return json;
+}
@@ -2,7 +2,39 @@
 
 #include "scanner.h"
 
+#include <functional>
 #include <string>
 #include <vector>
 
-std::string renderHtml(const std::vector<BlockToken>& tokens);
+struct HeadingEntry {
+    int level = 0;
+    std::string text;   // текст заголовка без разметки
+    size_t offset = 0;  // смещение строки заголовка в исходном файле (байты)
+    std::string slug;   // уникальный якорь для id="..."
+};
+
+using HeadingIndex = std::vector<HeadingEntry>;
+
+// Стадии рендера для замеров (--stats): разбор инлайн-разметки с подсчётом размера
+// и запись HTML. Хук вызывается при входе в стадию; последняя длится до возврата
+enum class RenderStage {
+    Inline,
+    Write
+};
+using RenderStageHook = std::function<void(RenderStage stage)>;
+
+// Если передан headings, индекс заголовков собирается в том же проходе,
+// а у <h1>-<h3> появляются атрибуты id
+std::string renderHtml(const std::vector<BlockToken>& tokens, HeadingIndex* headings = nullptr,
+                       const RenderStageHook& onStage = nullptr);
+// То же, но в out, переиспользуя его ёмкость (прежнее содержимое стирается)
+void renderHtmlInto(std::string& out, const std::vector<BlockToken>& tokens, HeadingIndex* headings = nullptr,
+                    const RenderStageHook& onStage = nullptr);
+
+// Потоковый вариант: HTML отдаётся в sink поблочно по мере рендеринга
+using HtmlSink = std::function<void(const std::string& chunk)>;
+void streamHtml(const std::vector<BlockToken>& tokens, const HtmlSink& sink, HeadingIndex* headings = nullptr,
+                const RenderStageHook& onStage = nullptr);
+
+std::string renderToc(const HeadingIndex& headings);
+std::string renderTocJson(const HeadingIndex& headings);
@@ -1,11 +1,60 @@
 #include "scanner.h"
+#include "inline_parser.h"
 
+#include <cctype>
 #include <regex>
+#include <stdexcept>
 #include <functional>
 
+// Регулярки компилируются один раз и общие для сканера и индекса блоков
+struct BlockRegexes {
+    std::regex heading{R"(^(#{1,3})\s+(.*)$)"};
+    std::regex ordered{R"(^[0-9]+\.\s+(.*)$)"};
+    std::regex unordered{R"(^[-*]\s+(.*)$)"};
+};
+
+static const BlockRegexes& blockRegexes() {
+    static const BlockRegexes regexes;
+    return regexes;
+}
+
+// Хвост строки после маркера: "\s+(.*)$". Пробельный символ обязателен,
+// а '\r' и '\n' ('.' их не принимает) допустимы только внутри этих пробелов
+static bool matchesMarkerBody(const std::string& line, size_t pos) {
+    if (pos >= line.size() || !std::isspace(static_cast<unsigned char>(line[pos]))) {
+        return false;
+    }
+    while (pos < line.size() && std::isspace(static_cast<unsigned char>(line[pos]))) {
+        ++pos;
+    }
+    return line.find_first_of("\r\n", pos) == std::string::npos;
+}
+
+// Побайтовая классификация строки, эквивалентная regex_match с регулярками выше
+static BlockType classifyLine(const std::string& line) {
+    if (line.empty()) {
+        return BlockType::Paragraph;
+    }
+    size_t pos = 0;
+    if (line[0] == '#') {
+        while (pos < line.size() && line[pos] == '#') ++pos;
+        return pos <= 3 && matchesMarkerBody(line, pos) ? BlockType::Heading : BlockType::Paragraph;
+    }
+    if (line[0] == '-' || line[0] == '*') {
+        return matchesMarkerBody(line, 1) ? BlockType::UnorderedList : BlockType::Paragraph;
+    }
+    if (std::isdigit(static_cast<unsigned char>(line[0]))) {
+        while (pos < line.size() && std::isdigit(static_cast<unsigned char>(line[pos]))) ++pos;
+        return pos < line.size() && line[pos] == '.' && matchesMarkerBody(line, pos + 1)
+             ? BlockType::OrderedList : BlockType::Paragraph;
+    }
+    return BlockType::Paragraph;
+}
+
 struct ScanContext {
     const std::vector<std::string>& lines;
     size_t& i;
+    size_t end; // сканируем строки [i, end)
     std::smatch& match;
     const std::regex& headingRe;
     const std::regex& orderedRe;
@@ -30,7 +79,7 @@ template<>
 BlockToken parseBlock<BlockType::OrderedList>(ScanContext& ctx) {
     BlockToken token;
     token.type = BlockType::OrderedList;
-    while (ctx.i < ctx.lines.size() && std::regex_match(ctx.lines[ctx.i], ctx.match, ctx.orderedRe)) {
+    while (ctx.i < ctx.end && std::regex_match(ctx.lines[ctx.i], ctx.match, ctx.orderedRe)) {
         token.lines.push_back(ctx.match[1].str());
         ++ctx.i;
     }
@@ -41,7 +90,7 @@ template<>
 BlockToken parseBlock<BlockType::UnorderedList>(ScanContext& ctx) {
     BlockToken token;
     token.type = BlockType::UnorderedList;
-    while (ctx.i < ctx.lines.size() && std::regex_match(ctx.lines[ctx.i], ctx.match, ctx.unorderedRe)) {
+    while (ctx.i < ctx.end && std::regex_match(ctx.lines[ctx.i], ctx.match, ctx.unorderedRe)) {
         token.lines.push_back(ctx.match[1].str());
         ++ctx.i;
     }
@@ -58,7 +107,7 @@ BlockToken parseBlock<BlockType::Paragraph>(ScanContext& ctx) {
             || std::regex_match(line, ctx.orderedRe)
             || std::regex_match(line, ctx.unorderedRe);
     };
-    while (ctx.i < ctx.lines.size() && !ctx.lines[ctx.i].empty() && !isBlockStart(ctx.lines[ctx.i])) {
+    while (ctx.i < ctx.end && !ctx.lines[ctx.i].empty() && !isBlockStart(ctx.lines[ctx.i])) {
         if (!paragraph.empty()) paragraph += " ";
         paragraph += ctx.lines[ctx.i];
         ++ctx.i;
@@ -67,24 +116,48 @@ BlockToken parseBlock<BlockType::Paragraph>(ScanContext& ctx) {
     return token;
 }
 
-std::vector<BlockToken> scan(const std::vector<std::string>& lines) {
+// Смещения строк: переданные из preprocess или, если их нет, как у строк,
+// склеенных через '\n'. storage нужен только во втором случае
+static const std::vector<size_t>& lineOffsetsOf(const std::vector<std::string>& lines,
+                                                const std::vector<size_t>* given,
+                                                std::vector<size_t>& storage) {
+    if (given) {
+        if (given->size() <= lines.size()) {
+            throw std::runtime_error("Line offsets do not match lines");
+        }
+        return *given;
+    }
+    storage.reserve(lines.size() + 1);
+    size_t offset = 0;
+    for (const auto& line : lines) {
+        storage.push_back(offset);
+        offset += line.size() + 1;
+    }
+    storage.push_back(offset);
+    return storage;
+}
+
+// offsets == nullptr — смещения блокам проставит вызывающий
+static std::vector<BlockToken> scanLines(const std::vector<std::string>& lines,
+                                         size_t begin, size_t end, const std::vector<size_t>* offsets) {
     std::vector<BlockToken> tokens;
 
     // При помощи регулярных выражений находим нужные блоки и отделяем в них текст
-    std::regex headingRe(R"(^(#{1,3})\s+(.*)$)");
-    std::regex orderedRe(R"(^[0-9]+\.\s+(.*)$)");
-    std::regex unorderedRe(R"(^[-*]\s+(.*)$)");
+    const std::regex& headingRe = blockRegexes().heading;
+    const std::regex& orderedRe = blockRegexes().ordered;
+    const std::regex& unorderedRe = blockRegexes().unordered;
 
-    size_t i = 0;
+    size_t i = begin;
     std::smatch match;
-    ScanContext ctx{lines, i, match, headingRe, orderedRe, unorderedRe};
+    ScanContext ctx{lines, i, end, match, headingRe, orderedRe, unorderedRe};
 
-    while (i < lines.size()) {
+    while (i < end) {
         if (lines[i].empty()) {
             ++i;
             continue;
         }
 
+        size_t start = i;
         if (std::regex_match(lines[i], match, headingRe)) {
             tokens.push_back(parseBlock<BlockType::Heading>(ctx));
         } else if (std::regex_match(lines[i], match, orderedRe)) {
@@ -94,7 +167,122 @@ std::vector<BlockToken> scan(const std::vector<std::string>& lines) {
         } else {
             tokens.push_back(parseBlock<BlockType::Paragraph>(ctx));
         }
+        if (offsets) {
+            tokens.back().offset = (*offsets)[start];
+        }
     }
 
     return tokens;
 }
+
+std::vector<BlockToken> scan(const std::vector<std::string>& lines, const std::vector<size_t>* lineOffsets) {
+    std::vector<size_t> storage;
+    return scanLines(lines, 0, lines.size(), &lineOffsetsOf(lines, lineOffsets, storage));
+}
+
+std::vector<BlockToken> scan(const std::vector<std::string>& lines, const BlockIndex& index, BlockRange range) {
+    if (range.empty() || range.last > index.size()) {
+        return {};
+    }
+    const BlockSpan& first = index[range.first];
+    auto tokens = scanLines(lines, first.firstLine, index[range.last - 1].endLine, nullptr);
+    // Границы блоков совпадают с индексом, поэтому смещения и якоря переносим по порядку —
+    // у раздела они те же, что и в полном документе
+    for (size_t k = 0; k < tokens.size() && range.first + k < range.last; ++k) {
+        tokens[k].offset = index[range.first + k].offset;
+        tokens[k].slug = index[range.first + k].slug;
+    }
+    return tokens;
+}
+
+// Индекс повторяет границы блоков сканера, но строки классифицирует побайтово,
+// не собирает их и не трогает инлайн-разметку. Регулярка нужна только заголовкам
+BlockIndex indexBlocks(const std::vector<std::string>& lines, const std::vector<size_t>* lineOffsets) {
+    BlockIndex index;
+    SlugRegistry usedSlugs;
+    std::smatch match;
+    std::vector<size_t> storage;
+    const std::vector<size_t>& offsets = lineOffsetsOf(lines, lineOffsets, storage);
+
+    size_t i = 0;
+    auto skipWhile = [&](BlockType type) {
+        while (i < lines.size() && !lines[i].empty() && classifyLine(lines[i]) == type) {
+            ++i;
+        }
+    };
+
+    while (i < lines.size()) {
+        if (lines[i].empty()) {
+            ++i;
+            continue;
+        }
+
+        BlockSpan span;
+        span.type = classifyLine(lines[i]);
+        span.firstLine = i;
+        span.offset = offsets[i];
+        switch (span.type) {
+            case BlockType::Heading:
+                std::regex_match(lines[i], match, blockRegexes().heading);
+                span.level = static_cast<int>(match[1].length());
+                span.heading = match[2].str();
+                span.text = inlinePlainText(parseInline(span.heading));
+                span.slug = uniqueSlug(span.text, usedSlugs);
+                ++i;
+                break;
+            case BlockType::OrderedList:
+            case BlockType::UnorderedList:
+                skipWhile(span.type);
+                break;
+            case BlockType::Paragraph:
+                skipWhile(BlockType::Paragraph);
+                break;
+        }
+        span.endLine = i;
+        span.endOffset = offsets[i];
+        index.push_back(std::move(span));
+    }
+
+    return index;
+}
+
+// Раздел — заголовок и все блоки до следующего заголовка того же или более высокого уровня.
+// Заголовок ищем по исходному тексту ("Intro *here*"), по тексту без разметки
+// ("Intro here") или по якорю (как в id="...")
+BlockRange sectionRange(const BlockIndex& index, const std::string& heading) {
+    for (size_t k = 0; k < index.size(); ++k) {
+        const BlockSpan& span = index[k];
+        if (span.type != BlockType::Heading) continue;
+        if (span.heading != heading && span.text != heading && span.slug != heading) continue;
+
+        size_t last = k + 1;
+        while (last < index.size()
+               && !(index[last].type == BlockType::Heading && index[last].level <= span.level)) {
+            ++last;
+        }
+        return {k, last};
+    }
+    return {};
+}
+
+BlockRange lineRange(const BlockIndex& index, size_t beginLine, size_t endLine) {
+    BlockRange range{index.size(), index.size()};
+    for (size_t k = 0; k < index.size(); ++k) {
+        if (index[k].endLine <= beginLine) continue;
+        if (index[k].firstLine >= endLine) break;
+        if (range.empty()) range.first = k;
+        range.last = k + 1;
+    }
+    return range.empty() ? BlockRange{} : range;
+}
+
+BlockRange byteRange(const BlockIndex& index, size_t beginOffset, size_t endOffset) {
+    BlockRange range{index.size(), index.size()};
+    for (size_t k = 0; k < index.size(); ++k) {
+        if (index[k].endOffset <= beginOffset) continue;
+        if (index[k].offset >= endOffset) break;
+        if (range.empty()) range.first = k;
+        range.last = k + 1;
+    }
+    return range.empty() ? BlockRange{} : range;
+}
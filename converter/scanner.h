@@ -16,6 +16,43 @@ struct BlockToken {
     BlockType type;
     int level = 0;
     std::vector<std::string> lines;
+    size_t offset = 0; // смещение первой строки блока в исходном тексте (байты)
+    std::string slug;  // якорь заголовка из BlockIndex; пусто — рендерер выдаст сам
 };
 
-std::vector<BlockToken> scan(const std::vector<std::string>& lines);
+// Дешёвый индекс блоков: тип, границы по строкам и байтам, без разбора содержимого
+struct BlockSpan {
+    BlockType type = BlockType::Paragraph;
+    int level = 0;
+    size_t firstLine = 0;
+    size_t endLine = 0;   // строка сразу за блоком
+    size_t offset = 0;
+    size_t endOffset = 0; // байт сразу за последней строкой блока
+    std::string heading;  // текст заголовка (только для Heading)
+    std::string text;     // он же без разметки — как его видит читатель
+    std::string slug;     // якорь заголовка, уникальный в пределах всего документа
+};
+
+using BlockIndex = std::vector<BlockSpan>;
+
+// Полуоткрытый диапазон [first, last) индексов в BlockIndex
+struct BlockRange {
+    size_t first = 0;
+    size_t last = 0;
+
+    bool empty() const { return first >= last; }
+};
+
+// lineOffsets — начала строк в исходном тексте из preprocess (на одну запись больше,
+// чем строк). Без них строки считаются исходным текстом, склеенным через '\n'
+std::vector<BlockToken> scan(const std::vector<std::string>& lines,
+                             const std::vector<size_t>* lineOffsets = nullptr);
+// Сканирует только строки блоков из range, остальной документ не трогает
+std::vector<BlockToken> scan(const std::vector<std::string>& lines, const BlockIndex& index, BlockRange range);
+
+BlockIndex indexBlocks(const std::vector<std::string>& lines,
+                       const std::vector<size_t>* lineOffsets = nullptr);
+// Заголовок ищется по исходному тексту, тексту без разметки или якорю
+BlockRange sectionRange(const BlockIndex& index, const std::string& heading);
+BlockRange lineRange(const BlockIndex& index, size_t beginLine, size_t endLine);
+BlockRange byteRange(const BlockIndex& index, size_t beginOffset, size_t endOffset);
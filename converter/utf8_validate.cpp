@@ -0,0 +1,195 @@
+#include "utf8_validate.h"
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define UTF8_VALIDATE_SSSE3 1
+#include <tmmintrin.h>
+#endif
+
+size_t decodeUtf8(const unsigned char* p, size_t avail, bool& valid) {
+    unsigned char lead = p[0];
+    size_t need = 0;
+    unsigned char lo = 0x80, hi = 0xBF; // допустимый диапазон второго байта
+    if (lead >= 0xC2 && lead <= 0xDF) {
+        need = 2;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+        need = 3;
+        if (lead == 0xE0) lo = 0xA0; // overlong
+        if (lead == 0xED) hi = 0x9F; // суррогаты
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+        need = 4;
+        if (lead == 0xF0) lo = 0x90; // overlong
+        if (lead == 0xF4) hi = 0x8F; // > U+10FFFF
+    } else {
+        valid = false;
+        return 1;
+    }
+
+    for (size_t k = 1; k < need; ++k) {
+        unsigned char c = k < avail ? p[k] : 0;
+        bool ok = k == 1 ? (c >= lo && c <= hi) : (c >= 0x80 && c <= 0xBF);
+        if (k >= avail || !ok) {
+            valid = false;
+            return k;
+        }
+    }
+    valid = true;
+    return need;
+}
+
+static bool isValidUtf8Scalar(const unsigned char* p, size_t n) {
+    size_t i = 0;
+    while (i < n) {
+        if (p[i] < 0x80) {
+            ++i;
+            continue;
+        }
+        bool valid = false;
+        i += decodeUtf8(p + i, n - i, valid);
+        if (!valid) return false;
+    }
+    return true;
+}
+
+#ifdef UTF8_VALIDATE_SSSE3
+
+namespace {
+
+// Классы ошибок для пары (предыдущий байт, текущий байт)
+constexpr uint8_t kTooShort = 1 << 0;   // 11______ 0_______ или 11______ 11______
+constexpr uint8_t kTooLong = 1 << 1;    // 0_______ 10______
+constexpr uint8_t kOverlong3 = 1 << 2;  // 11100000 100_____
+constexpr uint8_t kTooLarge = 1 << 3;   // 11110100 1001____ и выше
+constexpr uint8_t kSurrogate = 1 << 4;  // 11101101 101_____
+constexpr uint8_t kOverlong2 = 1 << 5;  // 1100000_ 10______
+constexpr uint8_t kTooLarge1000 = 1 << 6; // 11110101+ 1000____
+constexpr uint8_t kOverlong4 = 1 << 6;  // 11110000 1000____
+constexpr uint8_t kTwoConts = 1 << 7;   // 10______ 10______
+constexpr uint8_t kCarry = kTooShort | kTooLong | kTwoConts;
+
+#define UTF8_TABLE(...) _mm_setr_epi8(__VA_ARGS__)
+#define B(x) static_cast<char>(x)
+
+__attribute__((target("ssse3")))
+inline __m128i shiftRight4(__m128i v) {
+    return _mm_and_si128(_mm_srli_epi16(v, 4), _mm_set1_epi8(0x0F));
+}
+
+__attribute__((target("ssse3")))
+inline __m128i checkSpecialCases(__m128i input, __m128i prev1) {
+    const __m128i byte1HighTable = UTF8_TABLE(
+        B(kTooLong), B(kTooLong), B(kTooLong), B(kTooLong),
+        B(kTooLong), B(kTooLong), B(kTooLong), B(kTooLong),
+        B(kTwoConts), B(kTwoConts), B(kTwoConts), B(kTwoConts),
+        B(kTooShort | kOverlong2),
+        B(kTooShort),
+        B(kTooShort | kOverlong3 | kSurrogate),
+        B(kTooShort | kTooLarge | kTooLarge1000 | kOverlong4));
+    const __m128i byte1LowTable = UTF8_TABLE(
+        B(kCarry | kOverlong3 | kOverlong2 | kOverlong4),
+        B(kCarry | kOverlong2),
+        B(kCarry),
+        B(kCarry),
+        B(kCarry | kTooLarge),
+        B(kCarry | kTooLarge | kTooLarge1000),
+        B(kCarry | kTooLarge | kTooLarge1000),
+        B(kCarry | kTooLarge | kTooLarge1000),
+        B(kCarry | kTooLarge | kTooLarge1000),
+        B(kCarry | kTooLarge | kTooLarge1000),
+        B(kCarry | kTooLarge | kTooLarge1000),
+        B(kCarry | kTooLarge | kTooLarge1000),
+        B(kCarry | kTooLarge | kTooLarge1000),
+        B(kCarry | kTooLarge | kTooLarge1000 | kSurrogate),
+        B(kCarry | kTooLarge | kTooLarge1000),
+        B(kCarry | kTooLarge | kTooLarge1000));
+    const __m128i byte2HighTable = UTF8_TABLE(
+        B(kTooShort), B(kTooShort), B(kTooShort), B(kTooShort),
+        B(kTooShort), B(kTooShort), B(kTooShort), B(kTooShort),
+        B(kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge1000 | kOverlong4),
+        B(kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge),
+        B(kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge),
+        B(kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge),
+        B(kTooShort), B(kTooShort), B(kTooShort), B(kTooShort));
+
+    __m128i byte1High = _mm_shuffle_epi8(byte1HighTable, shiftRight4(prev1));
+    __m128i byte1Low = _mm_shuffle_epi8(byte1LowTable, _mm_and_si128(prev1, _mm_set1_epi8(0x0F)));
+    __m128i byte2High = _mm_shuffle_epi8(byte2HighTable, shiftRight4(input));
+    return _mm_and_si128(_mm_and_si128(byte1High, byte1Low), byte2High);
+}
+
+#undef B
+#undef UTF8_TABLE
+
+// Третий и четвёртый байты 3- и 4-байтовых последовательностей должны быть продолжениями
+__attribute__((target("ssse3")))
+inline __m128i checkMultibyteLengths(__m128i input, __m128i prevInput, __m128i special) {
+    __m128i prev2 = _mm_alignr_epi8(input, prevInput, 16 - 2);
+    __m128i prev3 = _mm_alignr_epi8(input, prevInput, 16 - 3);
+    __m128i isThird = _mm_subs_epu8(prev2, _mm_set1_epi8(static_cast<char>(0xE0 - 0x80)));
+    __m128i isFourth = _mm_subs_epu8(prev3, _mm_set1_epi8(static_cast<char>(0xF0 - 0x80)));
+    __m128i must23 = _mm_and_si128(_mm_or_si128(isThird, isFourth), _mm_set1_epi8(static_cast<char>(0x80)));
+    return _mm_xor_si128(must23, special);
+}
+
+// Ненулевой, если блок заканчивается незавершённой последовательностью
+__attribute__((target("ssse3")))
+inline __m128i isIncomplete(__m128i input) {
+    const __m128i maxValue = _mm_setr_epi8(
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        static_cast<char>(0xF0 - 1), static_cast<char>(0xE0 - 1), static_cast<char>(0xC0 - 1));
+    return _mm_subs_epu8(input, maxValue);
+}
+
+struct ValidatorState {
+    __m128i error = _mm_setzero_si128();
+    __m128i prevInput = _mm_setzero_si128();
+    __m128i prevIncomplete = _mm_setzero_si128();
+};
+
+__attribute__((target("ssse3")))
+inline void checkBlock(ValidatorState& state, __m128i input) {
+    if (_mm_movemask_epi8(input) == 0) {
+        // Чистый ASCII: ошибка возможна только от хвоста предыдущего блока
+        state.error = _mm_or_si128(state.error, state.prevIncomplete);
+    } else {
+        __m128i prev1 = _mm_alignr_epi8(input, state.prevInput, 16 - 1);
+        __m128i special = checkSpecialCases(input, prev1);
+        state.error = _mm_or_si128(state.error, checkMultibyteLengths(input, state.prevInput, special));
+        state.prevIncomplete = isIncomplete(input);
+    }
+    state.prevInput = input;
+}
+
+__attribute__((target("ssse3")))
+bool isValidUtf8Ssse3(const unsigned char* p, size_t n) {
+    ValidatorState state;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        checkBlock(state, _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i)));
+    }
+    if (i < n) {
+        // Хвост дополняем нулями: обрыв последовательности станет ошибкой kTooShort
+        unsigned char tail[16] = {};
+        std::memcpy(tail, p + i, n - i);
+        checkBlock(state, _mm_loadu_si128(reinterpret_cast<const __m128i*>(tail)));
+    }
+    __m128i error = _mm_or_si128(state.error, state.prevIncomplete);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(error, _mm_setzero_si128())) == 0xFFFF;
+}
+
+}
+
+#endif
+
+bool isValidUtf8(const char* data, size_t size) {
+    const auto* p = reinterpret_cast<const unsigned char*>(data);
+#ifdef UTF8_VALIDATE_SSSE3
+    static const bool hasSsse3 = __builtin_cpu_supports("ssse3");
+    if (hasSsse3) {
+        return isValidUtf8Ssse3(p, size);
+    }
+#endif
+    return isValidUtf8Scalar(p, size);
+}
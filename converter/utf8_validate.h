@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstddef>
+
+// Проверка UTF-8 блоками по 16 байт (алгоритм Кайзера–Лемира на таблицах pshufb).
+// На x86 с SSSE3 выбирается векторная версия, иначе — скалярная
+bool isValidUtf8(const char* data, size_t size);
+
+// Разбирает последовательность UTF-8 с начала p (p[0] >= 0x80). Возвращает число байт:
+// длину корректного символа или длину максимального битого префикса (valid = false)
+size_t decodeUtf8(const unsigned char* p, size_t avail, bool& valid);
@@ -1,28 +1,98 @@
 #include "utils.h"
+#include "utf8_validate.h"
 
+#include <algorithm>
+#include <cctype>
+#include <cstring>
 #include <fstream>
 #include <sstream>
 #include <stdexcept>
 
 std::string readFile(const std::string& path) {
-    std::ifstream file(path, std::ios::binary);
+    std::string result;
+    readFileInto(path, result);
+    return result;
+}
+
+void readFileInto(const std::string& path, std::string& out) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
     if (!file.is_open()) {
         throw std::runtime_error("Cannot open file: " + path);
     }
-    std::ostringstream ss;
-    ss << file.rdbuf();
-    return ss.str();
+    std::streamoff size = file.tellg();
+    if (size < 0) {
+        throw std::runtime_error("Cannot read file: " + path);
+    }
+    out.resize(static_cast<size_t>(size));
+    file.seekg(0);
+    if (size > 0 && !file.read(out.data(), size)) {
+        throw std::runtime_error("Cannot read file: " + path);
+    }
+}
+
+// Копирует [from, to) с заменой CRLF на LF. Возвращает, где остановились:
+// CRLF на границе забирает и '\n' за пределами to
+static size_t appendNormalized(std::string& out, const std::string& text, size_t from, size_t to) {
+    size_t pos = from;
+    while (pos < to) {
+        const void* cr = std::memchr(text.data() + pos, '\r', to - pos);
+        if (!cr) {
+            out.append(text, pos, to - pos);
+            return to;
+        }
+        size_t at = static_cast<size_t>(static_cast<const char*>(cr) - text.data());
+        out.append(text, pos, at - pos);
+        if (at + 1 < text.size() && text[at + 1] == '\n') {
+            out += '\n';
+            pos = at + 2;
+        } else {
+            out += '\r';
+            pos = at + 1;
+        }
+    }
+    return pos;
 }
 
-std::string normalizeLineEndings(const std::string& text) {
+// Текст идёт окнами: окно целиком проверяется векторно и копируется. Скалярный
+// разбор запускается только для окна с ошибкой — чтобы найти и заменить её
+std::string normalizeLineEndings(const std::string& text, Utf8Mode mode) {
+    constexpr size_t kWindow = 1024;
     std::string result;
     result.reserve(text.size());
-    for (size_t i = 0; i < text.size(); ++i) {
-        if (text[i] == '\r' && i + 1 < text.size() && text[i + 1] == '\n') {
-            result += '\n';
-            ++i;
-        } else {
-            result += text[i];
+    const auto* data = reinterpret_cast<const unsigned char*>(text.data());
+    size_t n = text.size();
+    size_t i = 0;
+    while (i < n) {
+        size_t end = std::min(n, i + kWindow);
+        // Окно заканчиваем на начале символа, чтобы не разрезать корректную последовательность
+        for (int k = 0; k < 3 && end < n && end > i + 1 && (data[end] & 0xC0) == 0x80; ++k) {
+            --end;
+        }
+        if (mode == Utf8Mode::Pass || isValidUtf8(text.data() + i, end - i)) {
+            i = appendNormalized(result, text, i, end);
+            continue;
+        }
+
+        while (i < end) {
+            unsigned char c = data[i];
+            if (c == '\r' && i + 1 < n && data[i + 1] == '\n') {
+                result += '\n';
+                i += 2;
+            } else if (c < 0x80) {
+                result += static_cast<char>(c);
+                ++i;
+            } else {
+                bool valid = false;
+                size_t len = decodeUtf8(data + i, n - i, valid);
+                if (valid) {
+                    result.append(text, i, len);
+                } else if (mode == Utf8Mode::Replace) {
+                    result += "\xEF\xBF\xBD";
+                } else {
+                    throw std::runtime_error("Invalid UTF-8 at byte " + std::to_string(i));
+                }
+                i += len;
+            }
         }
     }
     return result;
@@ -46,17 +116,132 @@ std::string trimRight(const std::string& line) {
     return line.substr(0, end + 1);
 }
 
+void preprocess(const std::string& raw, Utf8Mode mode, std::vector<std::string>& lines,
+                std::vector<size_t>* lineOffsets) {
+    std::string normalized = normalizeLineEndings(raw, mode);
+
+    // Режем как getline, но пишем в уже существующие строки, чтобы не терять их ёмкость
+    size_t count = 0;
+    size_t pos = 0;
+    while (pos < normalized.size()) {
+        size_t eol = normalized.find('\n', pos);
+        if (eol == std::string::npos) {
+            eol = normalized.size();
+        }
+        if (count == lines.size()) {
+            lines.emplace_back();
+        }
+        std::string& line = lines[count++];
+        line.assign(normalized, pos, eol - pos);
+        line.erase(line.find_last_not_of(" \t\r\n") + 1);
+        pos = eol + 1;
+    }
+    lines.resize(count);
+
+    if (!lineOffsets) {
+        return;
+    }
+    // Нормализация не добавляет и не убирает '\n', поэтому k-я строка начинается
+    // после k-го перевода строки исходного текста
+    lineOffsets->clear();
+    if (!raw.empty()) {
+        lineOffsets->push_back(0);
+    }
+    size_t from = 0;
+    while (const void* nl = std::memchr(raw.data() + from, '\n', raw.size() - from)) {
+        from = static_cast<size_t>(static_cast<const char*>(nl) - raw.data()) + 1;
+        if (from == raw.size()) {
+            break;
+        }
+        lineOffsets->push_back(from);
+    }
+    lineOffsets->push_back(raw.size());
+}
+
 std::string escapeHtml(const std::string& text) {
+    std::string result;
+    result.reserve(escapedHtmlSize(text));
+    appendEscapedHtml(result, text);
+    return result;
+}
+
+size_t escapedHtmlSize(const std::string& text) {
+    size_t size = text.size();
+    for (char c : text) {
+        switch (c) {
+            case '&': size += 4; break; // &amp;
+            case '<': size += 3; break; // &lt;
+            case '>': size += 3; break; // &gt;
+            case '"': size += 5; break; // &quot;
+            default: break;
+        }
+    }
+    return size;
+}
+
+void appendEscapedHtml(std::string& out, const std::string& text) {
+    for (char c : text) {
+        switch (c) {
+            case '&': out += "&amp;";  break;
+            case '<': out += "&lt;";   break;
+            case '>': out += "&gt;";   break;
+            case '"': out += "&quot;"; break;
+            default:  out += c;        break;
+        }
+    }
+}
+
+std::string escapeJson(const std::string& text) {
+    static const char* hex = "0123456789abcdef";
     std::string result;
     result.reserve(text.size());
     for (char c : text) {
         switch (c) {
-            case '&': result += "&amp;";  break;
-            case '<': result += "&lt;";   break;
-            case '>': result += "&gt;";   break;
-            case '"': result += "&quot;"; break;
-            default:  result += c;        break;
+            case '"':  result += "\\\""; break;
+            case '\\': result += "\\\\"; break;
+            case '\n': result += "\\n";  break;
+            case '\t': result += "\\t";  break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    result += "\\u00";
+                    result += hex[(c >> 4) & 0xF];
+                    result += hex[c & 0xF];
+                } else {
+                    result += c;
+                }
+                break;
         }
     }
     return result;
 }
+
+// ASCII приводим к нижнему регистру, пробелы и дефисы схлопываем в один '-',
+// прочую пунктуацию выбрасываем. Байты UTF-8 (кириллица и т.п.) оставляем как есть
+std::string slugify(const std::string& text) {
+    std::string result;
+    result.reserve(text.size());
+    bool pendingDash = false;
+    for (char c : text) {
+        unsigned char u = static_cast<unsigned char>(c);
+        if (u >= 0x80 || std::isalnum(u) || c == '_') {
+            if (pendingDash && !result.empty()) result += '-';
+            pendingDash = false;
+            result += static_cast<char>(u < 0x80 ? std::tolower(u) : u);
+        } else if (c == ' ' || c == '\t' || c == '-') {
+            pendingDash = true;
+        }
+    }
+    return result;
+}
+
+// Повторяющиеся якоря получают суффикс -1, -2, ...
+std::string uniqueSlug(const std::string& text, SlugRegistry& used) {
+    std::string base = slugify(text);
+    if (base.empty()) base = "section";
+    std::string slug = base;
+    while (used.count(slug)) {
+        slug = base + "-" + std::to_string(++used[base]);
+    }
+    used[slug] = 0;
+    return slug;
+}
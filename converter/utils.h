@@ -1,10 +1,35 @@
 #pragma once
 
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 std::string readFile(const std::string& path);
-std::string normalizeLineEndings(const std::string& text);
+// Читает файл в out, переиспользуя его ёмкость
+void readFileInto(const std::string& path, std::string& out);
+// Что делать с некорректным UTF-8 при предобработке
+enum class Utf8Mode {
+    Pass,    // пропускать байты как есть
+    Replace, // заменять каждую битую последовательность на U+FFFD
+    Reject   // бросать std::runtime_error
+};
+
+// CRLF -> LF и проверка UTF-8 за один проход
+std::string normalizeLineEndings(const std::string& text, Utf8Mode mode = Utf8Mode::Pass);
 std::vector<std::string> splitLines(const std::string& text);
 std::string trimRight(const std::string& line);
+// Предобработка входа: нормализация, разбиение на строки и обрезка пробелов в конце.
+// lines переиспользует свою ёмкость. В lineOffsets, если задан, — начало каждой
+// строки в raw (в байтах исходного файла) и последним элементом raw.size()
+void preprocess(const std::string& raw, Utf8Mode mode, std::vector<std::string>& lines,
+                std::vector<size_t>* lineOffsets = nullptr);
 std::string escapeHtml(const std::string& text);
+// Размер текста после escapeHtml — для точного резервирования вывода
+size_t escapedHtmlSize(const std::string& text);
+void appendEscapedHtml(std::string& out, const std::string& text);
+std::string escapeJson(const std::string& text);
+std::string slugify(const std::string& text);
+
+// Якоря, уже выданные в документе, и счётчик суффиксов для каждого
+using SlugRegistry = std::unordered_map<std::string, int>;
+std::string uniqueSlug(const std::string& text, SlugRegistry& used);
@@ -0,0 +1,95 @@
+#include "watcher.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+static bool isMarkdown(const std::string& name) {
+    return name.size() > 3 && name.compare(name.size() - 3, 3, ".md") == 0;
+}
+
+DirectoryWatcher::DirectoryWatcher(const std::string& dir) : dir(dir) {
+    fd = inotify_init1(IN_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot initialize inotify: " + std::string(std::strerror(errno)));
+    }
+    // IN_CLOSE_WRITE — обычное сохранение, IN_MOVED_TO — сохранение через переименование
+    wd = inotify_add_watch(fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (wd < 0) {
+        std::string reason = std::strerror(errno);
+        close(fd);
+        throw std::runtime_error("Cannot watch directory: " + dir + " (" + reason + ")");
+    }
+}
+
+DirectoryWatcher::~DirectoryWatcher() {
+    if (fd >= 0) close(fd);
+}
+
+std::vector<std::string> DirectoryWatcher::next(int quietMs) {
+    std::vector<std::string> changed;
+    pollfd pfd{fd, POLLIN, 0};
+    bool overflowed = false;
+
+    while (changed.empty() && !overflowed) {
+        if (poll(&pfd, 1, -1) < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error("inotify poll failed: " + std::string(std::strerror(errno)));
+        }
+        overflowed |= !readEvents(changed);
+    }
+
+    // Дебаунс: редакторы пишут файл несколькими событиями подряд
+    while (poll(&pfd, 1, quietMs) > 0) {
+        overflowed |= !readEvents(changed);
+    }
+
+    // События потеряны — какие файлы изменились, неизвестно, пересобираем всё
+    if (overflowed) {
+        return listMarkdownFiles(dir);
+    }
+
+    std::sort(changed.begin(), changed.end());
+    changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+    return changed;
+}
+
+bool DirectoryWatcher::readEvents(std::vector<std::string>& changed) {
+    alignas(inotify_event) char buf[16 * 1024];
+    ssize_t len = read(fd, buf, sizeof(buf));
+    if (len <= 0) {
+        return true;
+    }
+    bool complete = true;
+    for (char* p = buf; p < buf + len;) {
+        auto* event = reinterpret_cast<inotify_event*>(p);
+        if (event->mask & IN_Q_OVERFLOW) {
+            complete = false;
+        } else if (event->len > 0) {
+            std::string name = event->name;
+            if (isMarkdown(name)) {
+                changed.push_back(std::move(name));
+            }
+        }
+        p += sizeof(inotify_event) + event->len;
+    }
+    return complete;
+}
+
+std::vector<std::string> listMarkdownFiles(const std::string& dir) {
+    std::vector<std::string> names;
+    for (const auto& entry : std::filesystem::directory_iterator(dir)) {
+        std::string name = entry.path().filename().string();
+        if (entry.is_regular_file() && isMarkdown(name)) {
+            names.push_back(std::move(name));
+        }
+    }
+    std::sort(names.begin(), names.end());
+    return names;
+}
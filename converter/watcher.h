@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Следит за .md файлами в каталоге через inotify (только Linux)
+class DirectoryWatcher {
+public:
+    explicit DirectoryWatcher(const std::string& dir);
+    ~DirectoryWatcher();
+
+    DirectoryWatcher(const DirectoryWatcher&) = delete;
+    DirectoryWatcher& operator=(const DirectoryWatcher&) = delete;
+
+    // Блокируется до первого изменения, затем собирает «пачку» событий, пока
+    // они идут чаще раза в quietMs. Возвращает имена файлов без повторов.
+    // Если очередь inotify переполнилась, возвращает все .md файлы каталога
+    std::vector<std::string> next(int quietMs = 2);
+
+private:
+    // Возвращает false, если ядро сообщило о переполнении очереди
+    bool readEvents(std::vector<std::string>& changed);
+
+    std::string dir;
+    int fd = -1;
+    int wd = -1;
+};
+
+std::vector<std::string> listMarkdownFiles(const std::string& dir);
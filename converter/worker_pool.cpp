@@ -0,0 +1,48 @@
+#include "worker_pool.h"
+
+WorkerPool::WorkerPool(size_t threads) {
+    if (threads == 0) threads = 1;
+    workers.reserve(threads);
+    for (size_t k = 0; k < threads; ++k) {
+        workers.emplace_back(&WorkerPool::loop, this, k);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& t : workers) {
+        t.join();
+    }
+}
+
+void WorkerPool::run(const std::vector<Task>& tasks) {
+    if (tasks.empty()) return;
+    std::unique_lock<std::mutex> lock(mutex);
+    batch = &tasks;
+    nextTask = 0;
+    pending = tasks.size();
+    wake.notify_all();
+    done.wait(lock, [&] { return pending == 0; });
+    batch = nullptr;
+}
+
+void WorkerPool::loop(size_t worker) {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        wake.wait(lock, [&] { return stopping || (batch && nextTask < batch->size()); });
+        if (stopping) return;
+
+        const Task& task = (*batch)[nextTask++];
+        lock.unlock();
+        task(worker);
+        lock.lock();
+
+        if (--pending == 0) {
+            done.notify_one();
+        }
+    }
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Пул постоянно живущих потоков: между пачками задач потоки не пересоздаются.
+// Задача получает номер потока, чтобы переиспользовать его буферы
+class WorkerPool {
+public:
+    using Task = std::function<void(size_t worker)>;
+
+    explicit WorkerPool(size_t threads);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    size_t size() const { return workers.size(); }
+
+    // Выполняет все задачи и возвращает управление, когда они закончились
+    void run(const std::vector<Task>& tasks);
+
+private:
+    void loop(size_t worker);
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    const std::vector<Task>* batch = nullptr;
+    size_t nextTask = 0;
+    size_t pending = 0;
+    bool stopping = false;
+};
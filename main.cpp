@@ -5,16 +5,44 @@
 
 #include "utils.h"
 #include "scanner.h"
-#include "inline_parser.h"
 #include "renderer.h"
+#include "gzip_writer.h"
+#include "watcher.h"
+#include "worker_pool.h"
+#include "perf_counters.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <thread>
+
+enum class GzipMode {
+    None,
+    Both, // .html и .html.gz
+    Only  // только .html.gz
+};
 
 struct CliArgs {
     std::string inputPath;
     std::string outputPath;
+    std::string watchDir;
+    std::string tocPath;
+    std::string tocJsonPath;
+    std::string section;
+    bool anchors = false;
+    bool stats = false;
+    Utf8Mode utf8 = Utf8Mode::Pass;
+    GzipMode gzip = GzipMode::None;
 };
 
 void printUsage() {
-    std::cerr << "Usage: MarkdownToHTML --in <input.md> [--out <output.html>]\n";
+    std::cerr << "Usage: MarkdownToHTML --in <input.md> [--out <output.html>]\n"
+              << "                      [--anchors] [--toc <toc.html>] [--toc-json <toc.json>]\n"
+              << "                      [--section <heading text>] [--gzip | --gzip-only]\n"
+              << "                      [--utf8 pass|replace|reject] [--stats]\n"
+              << "       MarkdownToHTML --watch <dir> [--out <output dir>] [--anchors]\n"
+              << "                      [--utf8 pass|replace|reject]\n";
 }
 
 CliArgs parseArgs(int argc, char* argv[]) {
@@ -25,6 +53,35 @@ CliArgs parseArgs(int argc, char* argv[]) {
             args.inputPath = argv[++i];
         } else if (arg == "--out" && i + 1 < argc) {
             args.outputPath = argv[++i];
+        } else if (arg == "--watch" && i + 1 < argc) {
+            args.watchDir = argv[++i];
+        } else if (arg == "--toc" && i + 1 < argc) {
+            args.tocPath = argv[++i];
+        } else if (arg == "--toc-json" && i + 1 < argc) {
+            args.tocJsonPath = argv[++i];
+        } else if (arg == "--section" && i + 1 < argc) {
+            args.section = argv[++i];
+        } else if (arg == "--utf8" && i + 1 < argc) {
+            std::string mode = argv[++i];
+            if (mode == "pass") {
+                args.utf8 = Utf8Mode::Pass;
+            } else if (mode == "replace") {
+                args.utf8 = Utf8Mode::Replace;
+            } else if (mode == "reject") {
+                args.utf8 = Utf8Mode::Reject;
+            } else {
+                std::cerr << "Unknown --utf8 mode: " << mode << "\n";
+                printUsage();
+                exit(1);
+            }
+        } else if (arg == "--stats") {
+            args.stats = true;
+        } else if (arg == "--anchors") {
+            args.anchors = true;
+        } else if (arg == "--gzip") {
+            args.gzip = GzipMode::Both;
+        } else if (arg == "--gzip-only") {
+            args.gzip = GzipMode::Only;
         } else {
             std::cerr << "Unknown option: " << arg << "\n";
             printUsage();
@@ -32,8 +89,22 @@ CliArgs parseArgs(int argc, char* argv[]) {
         }
     }
 
-    if (args.inputPath.empty()) {
-        std::cerr << "Error: --in <input.md> is required\n";
+    if (args.inputPath.empty() == args.watchDir.empty()) {
+        std::cerr << "Error: exactly one of --in <input.md> or --watch <dir> is required\n";
+        printUsage();
+        exit(1);
+    }
+
+    if (!args.watchDir.empty() && (!args.tocPath.empty() || !args.tocJsonPath.empty()
+                                   || !args.section.empty() || args.gzip != GzipMode::None
+                                   || args.stats)) {
+        std::cerr << "Error: --watch supports only --out, --anchors and --utf8\n";
+        printUsage();
+        exit(1);
+    }
+
+    if (args.gzip != GzipMode::None && args.outputPath.empty()) {
+        std::cerr << "Error: --gzip requires --out <output.html>\n";
         printUsage();
         exit(1);
     }
@@ -41,39 +112,224 @@ CliArgs parseArgs(int argc, char* argv[]) {
     return args;
 }
 
-std::vector<std::string> preprocess(const std::string& raw) {
-    std::string normalized = normalizeLineEndings(raw);
-    std::vector<std::string> lines = splitLines(normalized);
-    for (auto& line : lines) {
-        line = trimRight(line);
+bool writeFile(const std::string& path, const std::string& content) {
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        std::cerr << "Error: Cannot write to file: " << path << "\n";
+        return false;
+    }
+    out << content;
+    return true;
+}
+
+// Конвертация одного файла в режиме наблюдения; raw — буфер потока, живёт между пересборками
+// Буферы одного потока watch-режима. Живут между пересборками, поэтому вход,
+// строки, индекс заголовков и HTML повторной конвертации пишутся в уже выделенную память
+struct ConvertBuffers {
+    std::string raw;
+    std::vector<std::string> lines;
+    HeadingIndex headings;
+    std::string html;
+};
+
+bool convertFile(const std::string& inPath, const std::string& outPath, const CliArgs& args,
+                 ConvertBuffers& buffers) {
+    try {
+        readFileInto(inPath, buffers.raw);
+        preprocess(buffers.raw, args.utf8, buffers.lines);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " + inPath + ": " + e.what() + "\n";
+        return false;
+    }
+    buffers.headings.clear();
+    renderHtmlInto(buffers.html, scan(buffers.lines), args.anchors ? &buffers.headings : nullptr);
+    return writeFile(outPath, buffers.html);
+}
+
+int runWatch(const CliArgs& args) {
+    namespace fs = std::filesystem;
+    fs::path inDir = args.watchDir;
+    fs::path outDir = args.outputPath.empty() ? inDir : fs::path(args.outputPath);
+
+    std::error_code ec;
+    fs::create_directories(outDir, ec);
+    if (ec) {
+        std::cerr << "Error: Cannot create directory: " << outDir.string() << "\n";
+        return 1;
+    }
+
+    try {
+        // Наблюдение начинаем до первой сборки, чтобы не потерять сохранения во время неё
+        DirectoryWatcher watcher(inDir.string());
+        WorkerPool pool(std::max(1u, std::thread::hardware_concurrency()));
+        std::vector<ConvertBuffers> buffers(pool.size());
+
+        auto rebuild = [&](const std::vector<std::string>& names) {
+            auto start = std::chrono::steady_clock::now();
+            std::vector<WorkerPool::Task> tasks;
+            tasks.reserve(names.size());
+            for (const auto& name : names) {
+                tasks.push_back([&, name](size_t worker) {
+                    fs::path out = outDir / fs::path(name).replace_extension(".html");
+                    convertFile((inDir / name).string(), out.string(), args, buffers[worker]);
+                });
+            }
+            pool.run(tasks);
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            std::cerr << "Converted " << names.size() << " file(s) in " << elapsed.count() << " ms\n";
+        };
+
+        rebuild(listMarkdownFiles(inDir.string()));
+        for (;;) {
+            rebuild(watcher.next());
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
     }
-    return lines;
 }
 
 int main(int argc, char* argv[]) {
     CliArgs args = parseArgs(argc, argv);
+    if (!args.watchDir.empty()) {
+        return runWatch(args);
+    }
 
-    std::string raw;
+    // --stats: время и аппаратные счётчики по стадиям, в пересчёте на байт входа
+    std::unique_ptr<PerfCounters> perf;
+    if (args.stats) perf = std::make_unique<PerfCounters>();
+    std::string statsReport;
+    size_t inputBytes = 0;
+    auto stageStart = [&] {
+        if (perf) perf->start();
+    };
+    auto stageEnd = [&](const char* stage) {
+        if (perf) statsReport += formatPerfSample(stage, perf->stop(), inputBytes);
+    };
+
+    std::vector<std::string> lines;
+    std::vector<size_t> lineOffsets;
     try {
-        raw = readFile(args.inputPath);
+        stageStart();
+        std::string raw = readFile(args.inputPath);
+        inputBytes = raw.size();
+        stageEnd("read");
+
+        stageStart();
+        preprocess(raw, args.utf8, lines, &lineOffsets);
+        stageEnd("preprocess");
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << "\n";
         return 1;
     }
 
-    std::vector<std::string> lines = preprocess(raw);
-    std::vector<BlockToken> tokens = scan(lines);
-    std::string html = renderHtml(tokens);
+    stageStart();
+    std::vector<BlockToken> tokens;
+    if (args.section.empty()) {
+        tokens = scan(lines, &lineOffsets);
+    } else {
+        // Сканируем и рендерим только блоки выбранного раздела
+        BlockIndex index = indexBlocks(lines, &lineOffsets);
+        BlockRange range = sectionRange(index, args.section);
+        if (range.empty()) {
+            std::cerr << "Error: Section not found: " << args.section << "\n";
+            return 1;
+        }
+        tokens = scan(lines, index, range);
+    }
+    stageEnd("scan");
 
-    if (args.outputPath.empty()) {
-        std::cout << html;
+    // Стадии рендера (инлайн-разбор и запись) чередуются пачками блоков,
+    // поэтому их замеры копятся по стадиям и попадают в отчёт суммой
+    PerfSample renderStages[2];
+    RenderStage currentStage = RenderStage::Inline;
+    bool inRenderStage = false;
+    RenderStageHook onStage;
+    auto endRenderStage = [&] {
+        if (!inRenderStage) return;
+        renderStages[static_cast<size_t>(currentStage)].add(perf->stop());
+        inRenderStage = false;
+    };
+    auto reportRenderStages = [&] {
+        if (!perf) return;
+        endRenderStage();
+        statsReport += formatPerfSample("inline", renderStages[static_cast<size_t>(RenderStage::Inline)], inputBytes);
+        statsReport += formatPerfSample("render", renderStages[static_cast<size_t>(RenderStage::Write)], inputBytes);
+    };
+    if (perf) {
+        onStage = [&](RenderStage stage) {
+            endRenderStage();
+            currentStage = stage;
+            inRenderStage = true;
+            perf->start();
+        };
+    }
+
+    // Индекс заголовков собирается рендерером в том же проходе
+    bool wantHeadings = args.anchors || !args.tocPath.empty() || !args.tocJsonPath.empty();
+    HeadingIndex headings;
+    std::string html;
+
+    if (args.gzip == GzipMode::None) {
+        html = renderHtml(tokens, wantHeadings ? &headings : nullptr, onStage);
+        reportRenderStages();
     } else {
-        std::ofstream out(args.outputPath);
-        if (!out.is_open()) {
-            std::cerr << "Error: Cannot write to file: " << args.outputPath << "\n";
+        // Сжатие идёт в отдельном потоке параллельно с рендерингом,
+        // куски копим до kGzipBatch, чтобы не дёргать очередь на каждый блок
+        constexpr size_t kGzipBatch = 64 * 1024;
+        try {
+            // .html в режиме Both пишется теми же кусками прямо в файл, без копии в памяти
+            std::ofstream htmlFile;
+            if (args.gzip == GzipMode::Both) {
+                htmlFile.open(args.outputPath, std::ios::binary);
+                if (!htmlFile.is_open()) {
+                    throw std::runtime_error("Cannot write to file: " + args.outputPath);
+                }
+            }
+            GzipWriter gz(args.outputPath + ".gz");
+            std::string pending;
+            auto flush = [&] {
+                if (htmlFile.is_open()) htmlFile.write(pending.data(), static_cast<std::streamsize>(pending.size()));
+                gz.write(std::move(pending));
+                pending.clear();
+            };
+            streamHtml(tokens, [&](const std::string& chunk) {
+                pending += chunk;
+                if (pending.size() >= kGzipBatch) flush();
+            }, wantHeadings ? &headings : nullptr, onStage);
+            reportRenderStages();
+            // Ожидание компрессора — отдельная стадия, в рендер она не входит
+            stageStart();
+            flush();
+            gz.finish();
+            stageEnd("gzip-wait");
+            if (htmlFile.is_open() && !htmlFile.flush()) {
+                throw std::runtime_error("Cannot write to file: " + args.outputPath);
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << "\n";
             return 1;
         }
-        out << html;
+    }
+
+    if (args.outputPath.empty()) {
+        std::cout << html;
+    } else if (args.gzip == GzipMode::None && !writeFile(args.outputPath, html)) {
+        return 1;
+    }
+
+    if (!args.tocPath.empty() && !writeFile(args.tocPath, renderToc(headings))) {
+        return 1;
+    }
+    if (!args.tocJsonPath.empty() && !writeFile(args.tocJsonPath, renderTocJson(headings))) {
+        return 1;
+    }
+
+    if (perf) {
+        if (!perf->available()) {
+            std::cerr << "Hardware counters unavailable, reporting wall time only\n";
+        }
+        std::cerr << "Stats for " << inputBytes << " bytes:\n" << statsReport;
     }
 
     return 0;